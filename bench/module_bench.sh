@@ -0,0 +1,92 @@
+#!/bin/bash
+# Compares the compile time of translation units that include the generated
+# registry as a header against the same units importing it as a C++20 module.
+#
+# Usage: bench/module_bench.sh [num_tus] [ids_per_tu]
+# Environment: CXX (default g++), METACOUNTER (default: builds bin/metacounter)
+
+set -e
+
+NUM_TUS=${1:-300}
+IDS_PER_TU=${2:-10}
+CXX=${CXX:-g++}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+if [ -z "$METACOUNTER" ]; then
+    (cd "$ROOT" && bash build.sh > /dev/null)
+    METACOUNTER=$ROOT/bin/metacounter
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+echo "Generating $NUM_TUS translation units with $IDS_PER_TU counters each..."
+mkdir -p src
+for ((t = 0; t < NUM_TUS; ++t)); do
+    {
+        echo "#include \"../registry.h\""
+        echo "int tu_$t(int i) {"
+        echo "    int sum = 0;"
+        for ((i = 0; i < IDS_PER_TU; ++i)); do
+            echo "    sum += (int)REGISTER_COUNTER(Counter_${t}_${i});"
+        done
+        echo "    return sum + (int)MAX_COUNT_INT + (get_name_for_CounterID((CounterID)i)[0] == 'C');"
+        echo "}"
+    } > src/tu_$t.cpp
+done
+
+cat > header.txt <<CFG
+output_file: registry.h
+scan_ext: .cpp
+begin_sources
+src/
+end_sources
+CFG
+
+cat > module.txt <<CFG
+output_file: registry.h
+output_mode: module
+module_file: registry.cppm
+scan_ext: .cpp
+begin_sources
+src/
+end_sources
+CFG
+
+now() { date +%s.%N; }
+elapsed() { awk -v a="$1" -v b="$2" 'BEGIN { printf "%.2f", b - a }'; }
+
+compile_all() {
+    for ((t = 0; t < NUM_TUS; ++t)); do
+        $CXX -std=c++20 "$@" -c src/tu_$t.cpp -o src/tu_$t.o
+    done
+}
+
+# --- Header mode ---
+"$METACOUNTER" header.txt > /dev/null
+start=$(now)
+compile_all
+header_time=$(elapsed "$start" "$(now)")
+
+# --- Module mode ---
+"$METACOUNTER" module.txt > /dev/null
+rm -f src/*.o
+start=$(now)
+if $CXX --version | grep -qi clang; then
+    $CXX -std=c++20 --precompile -x c++-module registry.cppm -o registry.pcm
+    $CXX -std=c++20 -c registry.pcm -o registry.o
+    bmi_time=$(elapsed "$start" "$(now)")
+    start=$(now)
+    compile_all -fmodule-file=metacounter.registry=registry.pcm
+else
+    $CXX -std=c++20 -fmodules-ts -x c++ -c registry.cppm -o registry.o
+    bmi_time=$(elapsed "$start" "$(now)")
+    start=$(now)
+    compile_all -fmodules-ts
+fi
+module_time=$(elapsed "$start" "$(now)")
+
+echo "Compiler:            $($CXX --version | head -n 1)"
+echo "Identifiers:         $((NUM_TUS * IDS_PER_TU))"
+echo "Header mode:         ${header_time}s for $NUM_TUS TUs"
+echo "Module mode:         ${module_time}s for $NUM_TUS TUs (+ ${bmi_time}s to build the BMI once)"
@@ -2,12 +2,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/stat.h>
 
 // Platform-specific headers
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
 #else
 #include <dirent.h>
 #include <sys/mman.h>
@@ -15,7 +18,11 @@
 #endif
 
 #define MAX_LINE_LEN 2048
+#define MAX_PATH_LEN 4096
+#define MAX_INCLUDE_DIRS 256
+#define COMPDB_FILENAME "compile_commands.json"
 #define CONFIG_FILENAME "metacounter.txt"
+#define PARTIAL_MAGIC "MCPART01"
 
 // --- Forward Declarations ---
 typedef struct Arena Arena;
@@ -30,6 +37,7 @@ typedef struct {
     int line_num;
     int is_unique_request;
     int value;
+    int file_seq;
 } IdentifierInfo;
 
 typedef struct {
@@ -38,6 +46,7 @@ typedef struct {
     const char* count_name;
     const char* marker_std;
     const char* marker_unique;
+    const char* module_name;
     const IdentifierInfo* identifiers;
     size_t count;
     int max_value;
@@ -47,18 +56,34 @@ IdentifierInfo *g_identifiers = NULL;
 size_t g_id_count = 0;
 size_t g_id_capacity = 0;
 
+// Heap-allocated open-addressing set of canonical paths; see mark_file_visited().
+char **g_visited_files = NULL;
+size_t g_visited_count = 0;
+size_t g_visited_capacity = 0;
+int g_dedupe_files = 0;
+
 char **g_extensions = NULL;
 size_t g_ext_count = 0;
 size_t g_ext_capacity = 0;
 
 typedef enum { POLICY_IGNORE, POLICY_WARN, POLICY_ERROR } DuplicatePolicy;
+typedef enum { OUTPUT_HEADER, OUTPUT_MODULE } OutputMode;
 
 DuplicatePolicy g_policy = POLICY_IGNORE;
+OutputMode g_output_mode = OUTPUT_HEADER;
 char g_output_file[MAX_LINE_LEN] = {0};
+char g_module_file[MAX_LINE_LEN] = {0};
+char g_module_name[128] = "metacounter.registry";
 char g_enum_name[128] = "CounterID";
 char g_count_name[128] = "MAX_COUNT";
 char g_marker_std[128] = "REGISTER_COUNTER";
 char g_marker_unique[128] = "REGISTER_UNIQUE_COUNTER";
+int g_compdb_headers = 0;
+unsigned int g_shard_index = 0;
+unsigned int g_shard_count = 0;
+int g_file_seq_count = 0;
+int g_current_file_seq = 0;
+char g_project_root[MAX_PATH_LEN] = {0};
 
 Arena g_main_arena;
 
@@ -87,6 +112,7 @@ void add_identifier(const char *name, const char *filepath, int line_num, int is
     g_identifiers[g_id_count].line_num = line_num;
     g_identifiers[g_id_count].is_unique_request = is_unique;
     g_identifiers[g_id_count].value = value;
+    g_identifiers[g_id_count].file_seq = g_current_file_seq;
     g_id_count++;
 }
 
@@ -103,39 +129,82 @@ void add_extension(const char *ext) {
     g_extensions[g_ext_count++] = arena_strdup(&g_main_arena, ext);
 }
 
-void parse_line_for_markers(char *line, const char *filepath, int line_num) {
-    char marker_std_full[256], marker_unique_full[256];
-    snprintf(marker_std_full, sizeof(marker_std_full), "%s(", g_marker_std);
-    snprintf(marker_unique_full, sizeof(marker_unique_full), "%s(", g_marker_unique);
+static unsigned int hash_string(const char *s) {
+    unsigned int hash = 2166136261u;
+    while (*s) {
+        hash ^= (unsigned char)*s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
-    const char *markers[] = {marker_std_full, marker_unique_full};
-    for (int i = 0; i < 2; ++i) {
-        char *start = strstr(line, markers[i]);
-        if (start) {
-            start += strlen(markers[i]);
-            char *end = strchr(start, ')');
-            if (end) {
-                char identifier[256] = {0};
-                int value = -1;
-
-                while (start < end && (*start == ' ' || *start == '\t')) start++;
-
-                char *p = start;
-                while (p < end && *p != ',' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
-                
-                size_t len = p - start;
-                if (len > 0 && len < 255) {
-                    strncpy(identifier, start, len);
-                    
-                    char* comma = strchr(p, ',');
-                    if (comma && comma < end) {
-                        value = strtol(comma + 1, NULL, 10);
-                    }
-                    add_identifier(identifier, filepath, line_num, i == 1, value);
-                }
-            }
+static int canonicalize_path(const char *path, char *out) {
+#ifdef _WIN32
+    return _fullpath(out, path, MAX_PATH_LEN) != NULL;
+#else
+    char resolved[PATH_MAX];
+    if (!realpath(path, resolved)) return 0;
+    size_t len = strlen(resolved);
+    if (len >= MAX_PATH_LEN) return 0;
+    memcpy(out, resolved, len + 1);
+    return 1;
+#endif
+}
+
+static void* checked_malloc(size_t size) {
+    void* block = malloc(size);
+    if (!block) {
+        fprintf(stderr, "FATAL: Out of memory.\n");
+        exit(1);
+    }
+    return block;
+}
+
+// Returns 1 the first time a file is seen, 0 afterwards. Files reached through
+// several sources (overlapping source entries, headers shared by many
+// translation units) are only scanned once. When the sources cannot overlap
+// (g_dedupe_files unset) every file is new and no path is canonicalized.
+int mark_file_visited(const char *filepath) {
+    if (!g_dedupe_files) return 1;
+
+    char canonical[MAX_PATH_LEN];
+    const char *key = canonicalize_path(filepath, canonical) ? canonical : filepath;
+
+    if ((g_visited_count + 1) * 2 > g_visited_capacity) {
+        size_t new_capacity = (g_visited_capacity == 0) ? 256 : g_visited_capacity * 2;
+        char** new_block = checked_malloc(new_capacity * sizeof(char*));
+        memset(new_block, 0, new_capacity * sizeof(char*));
+        for (size_t i = 0; i < g_visited_capacity; ++i) {
+            if (!g_visited_files[i]) continue;
+            size_t slot = hash_string(g_visited_files[i]) & (new_capacity - 1);
+            while (new_block[slot]) slot = (slot + 1) & (new_capacity - 1);
+            new_block[slot] = g_visited_files[i];
         }
+        free(g_visited_files);
+        g_visited_files = new_block;
+        g_visited_capacity = new_capacity;
+    }
+
+    size_t slot = hash_string(key) & (g_visited_capacity - 1);
+    while (g_visited_files[slot]) {
+        if (strcmp(g_visited_files[slot], key) == 0) return 0;
+        slot = (slot + 1) & (g_visited_capacity - 1);
+    }
+    size_t len = strlen(key) + 1;
+    g_visited_files[slot] = checked_malloc(len);
+    memcpy(g_visited_files[slot], key, len);
+    g_visited_count++;
+    return 1;
+}
+
+static void free_visited_files(void) {
+    for (size_t i = 0; i < g_visited_capacity; ++i) {
+        free(g_visited_files[i]);
     }
+    free(g_visited_files);
+    g_visited_files = NULL;
+    g_visited_count = 0;
+    g_visited_capacity = 0;
 }
 
 int has_valid_extension(const char *filename) {
@@ -149,42 +218,473 @@ int has_valid_extension(const char *filename) {
 
 void process_path(const char *path);
 
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+typedef struct {
+    char** items;
+    size_t count;
+    size_t capacity;
+} NameList;
+
+// Name lists are short-lived (one directory listing, one file's includes),
+// so they use the heap and are released with name_list_free().
+static void name_list_push(NameList* list, const char* name) {
+    if (list->count >= list->capacity) {
+        size_t new_capacity = (list->capacity == 0) ? 32 : list->capacity * 2;
+        char** new_block = realloc(list->items, new_capacity * sizeof(char*));
+        if (!new_block) {
+            fprintf(stderr, "FATAL: Out of memory.\n");
+            exit(1);
+        }
+        list->items = new_block;
+        list->capacity = new_capacity;
+    }
+    size_t len = strlen(name) + 1;
+    list->items[list->count] = checked_malloc(len);
+    memcpy(list->items[list->count], name, len);
+    list->count++;
+}
+
+static void name_list_free(NameList* list) {
+    for (size_t i = 0; i < list->count; ++i) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// Entries are visited in sorted order so that every process (and every
+// machine) walking the same tree sees files in the same sequence.
 void process_directory(const char *dirpath) {
     char path_buffer[MAX_LINE_LEN];
+    NameList names = {0};
 #ifdef _WIN32
+    const char* separator = "\\";
     WIN32_FIND_DATA fd;
     snprintf(path_buffer, sizeof(path_buffer), "%s\\*", dirpath);
     HANDLE hFind = FindFirstFile(path_buffer, &fd);
     if (hFind == INVALID_HANDLE_VALUE) return;
     do {
         if (strcmp(fd.cFileName, ".") == 0 || strcmp(fd.cFileName, "..") == 0) continue;
-        snprintf(path_buffer, sizeof(path_buffer), "%s\\%s", dirpath, fd.cFileName);
-        process_path(path_buffer);
+        name_list_push(&names, fd.cFileName);
     } while (FindNextFile(hFind, &fd) != 0);
     FindClose(hFind);
 #else
+    const char* separator = "/";
     DIR *dir = opendir(dirpath);
     if (!dir) return;
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
-        snprintf(path_buffer, sizeof(path_buffer), "%s/%s", dirpath, entry->d_name);
-        process_path(path_buffer);
+        name_list_push(&names, entry->d_name);
     }
     closedir(dir);
 #endif
+
+    if (names.count > 1) qsort(names.items, names.count, sizeof(char*), compare_names);
+    for (size_t i = 0; i < names.count; ++i) {
+        snprintf(path_buffer, sizeof(path_buffer), "%s%s%s", dirpath, separator, names.items[i]);
+        process_path(path_buffer);
+    }
+    name_list_free(&names);
 }
 
-void process_file(const char *filepath) {
-    FILE *file = fopen(filepath, "r");
-    if (!file) return;
-    char line[MAX_LINE_LEN];
-    int line_num = 0;
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        parse_line_for_markers(line, filepath, line_num);
+// --- Marker Scanning ---
+//
+// A single pass over the whole file that understands enough of C/C++ lexing
+// to ignore markers in comments, string/character literals and '#if 0'
+// blocks, and to find markers whose arguments span several lines.
+
+#define MAX_COND_DEPTH 64
+
+typedef enum { COND_OTHER, COND_TRUE } CondKind;
+
+typedef struct {
+    const char* p;
+    const char* end;
+    const char* filepath;
+    int line;
+    int at_line_start;
+    // Set from a directive's '#' to its (unescaped) end of line.
+    int in_directive;
+    NameList* includes;
+    // Depth inside a dead conditional group; 0 when the code is live.
+    int skip_depth;
+    // Set when the dead group can only end at '#endif' (the '#else' of '#if 1').
+    int skip_to_endif;
+    CondKind conds[MAX_COND_DEPTH];
+    int cond_depth;
+} Lexer;
+
+static char* read_entire_file(const char* path, size_t* out_size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
     }
+    char* buffer = malloc((size_t)size + 1);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+    size_t read = fread(buffer, 1, (size_t)size, file);
     fclose(file);
+    buffer[read] = '\0';
+    *out_size = read;
+    return buffer;
+}
+
+static int is_ident_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static int is_ident_char(char c) {
+    return is_ident_start(c) || (c >= '0' && c <= '9');
+}
+
+static int is_raw_string_prefix(const char* s, size_t len) {
+    return (len == 1 && s[0] == 'R') ||
+           (len == 2 && (s[0] == 'u' || s[0] == 'U' || s[0] == 'L') && s[1] == 'R') ||
+           (len == 3 && s[0] == 'u' && s[1] == '8' && s[2] == 'R');
+}
+
+static void lex_newline(Lexer* lx) {
+    lx->p++;
+    lx->line++;
+    lx->at_line_start = 1;
+    lx->in_directive = 0;
+}
+
+static void lex_skip_line_comment(Lexer* lx) {
+    while (lx->p < lx->end && *lx->p != '\n') {
+        if (*lx->p == '\\' && lx->p + 1 < lx->end && lx->p[1] == '\n') {
+            lx->p++;
+            lx->line++;
+        }
+        lx->p++;
+    }
+}
+
+static void lex_skip_block_comment(Lexer* lx) {
+    lx->p += 2;
+    while (lx->p < lx->end) {
+        if (*lx->p == '*' && lx->p + 1 < lx->end && lx->p[1] == '/') {
+            lx->p += 2;
+            return;
+        }
+        if (*lx->p == '\n') lx->line++;
+        lx->p++;
+    }
+}
+
+// Skips a quoted literal; an unescaped newline ends an unterminated one.
+static void lex_skip_quoted(Lexer* lx, char quote) {
+    lx->p++;
+    while (lx->p < lx->end && *lx->p != quote && *lx->p != '\n') {
+        if (*lx->p == '\\' && lx->p + 1 < lx->end) {
+            if (lx->p[1] == '\n') lx->line++;
+            lx->p++;
+        }
+        lx->p++;
+    }
+    if (lx->p < lx->end && *lx->p == quote) lx->p++;
+}
+
+// p points at the opening quote of R"delim( ... )delim".
+static void lex_skip_raw_string(Lexer* lx) {
+    const char* delim = ++lx->p;
+    while (lx->p < lx->end && *lx->p != '(' && lx->p - delim < 16) lx->p++;
+    if (lx->p >= lx->end || *lx->p != '(') return;
+    size_t delim_len = (size_t)(lx->p - delim);
+    lx->p++;
+    while (lx->p < lx->end) {
+        if (*lx->p == ')' && (size_t)(lx->end - lx->p) > delim_len + 1 &&
+            memcmp(lx->p + 1, delim, delim_len) == 0 && lx->p[1 + delim_len] == '"') {
+            lx->p += delim_len + 2;
+            return;
+        }
+        if (*lx->p == '\n') lx->line++;
+        lx->p++;
+    }
+}
+
+// Skips whitespace, line continuations and comments. Newlines are crossed
+// too, except the one that ends a directive.
+static void lex_skip_space(Lexer* lx) {
+    while (lx->p < lx->end) {
+        char c = *lx->p;
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') lx->p++;
+        else if (c == '\n' && !lx->in_directive) lex_newline(lx);
+        else if (c == '\\' && lx->p + 1 < lx->end && lx->p[1] == '\n') { lx->p += 2; lx->line++; }
+        else if (c == '/' && lx->p + 1 < lx->end && lx->p[1] == '/') lex_skip_line_comment(lx);
+        else if (c == '/' && lx->p + 1 < lx->end && lx->p[1] == '*') lex_skip_block_comment(lx);
+        else return;
+    }
+}
+
+static void lex_skip_inline_space(Lexer* lx) {
+    while (lx->p < lx->end && (*lx->p == ' ' || *lx->p == '\t')) lx->p++;
+}
+
+// Parses '(name[, value])' after a marker. Anything that does not look like
+// a call is left for the main loop.
+static void lex_marker_call(Lexer* lx, int is_unique, int line_num) {
+    lex_skip_space(lx);
+    if (lx->p >= lx->end || *lx->p != '(') return;
+    lx->p++;
+    lex_skip_space(lx);
+
+    const char* start = lx->p;
+    while (lx->p < lx->end && is_ident_char(*lx->p)) lx->p++;
+    size_t len = (size_t)(lx->p - start);
+    if (len == 0 || len >= 255) return;
+
+    char identifier[256];
+    memcpy(identifier, start, len);
+    identifier[len] = '\0';
+
+    int value = -1;
+    lex_skip_space(lx);
+    if (lx->p < lx->end && *lx->p == ',') {
+        lx->p++;
+        lex_skip_space(lx);
+        char* value_end = NULL;
+        long parsed = strtol(lx->p, &value_end, 10);
+        if (value_end != lx->p) {
+            value = (int)parsed;
+            lx->p = value_end;
+        }
+    }
+    add_identifier(identifier, lx->filepath, line_num, is_unique, value);
+}
+
+// Reads the controlling expression of '#if'/'#elif' when it is a bare 0 or 1;
+// returns -1 for anything else.
+static int lex_constant_condition(Lexer* lx) {
+    lex_skip_inline_space(lx);
+    const char* start = lx->p;
+    while (lx->p < lx->end && is_ident_char(*lx->p)) lx->p++;
+    size_t len = (size_t)(lx->p - start);
+    lex_skip_inline_space(lx);
+    int ends_here = lx->p >= lx->end || *lx->p == '\n' || *lx->p == '\r' ||
+                    (*lx->p == '/' && lx->p + 1 < lx->end && (lx->p[1] == '/' || lx->p[1] == '*'));
+    if (!ends_here || len != 1) return -1;
+    if (*start == '0') return 0;
+    if (*start == '1') return 1;
+    return -1;
+}
+
+// p points just past '#'. Updates the conditional state; the remainder of
+// the directive is left to the main loop.
+static void lex_directive(Lexer* lx) {
+    lex_skip_inline_space(lx);
+    const char* name = lx->p;
+    while (lx->p < lx->end && is_ident_char(*lx->p)) lx->p++;
+    size_t len = (size_t)(lx->p - name);
+#define DIRECTIVE_IS(s) (len == sizeof(s) - 1 && memcmp(name, s, len) == 0)
+    int opens = DIRECTIVE_IS("if") || DIRECTIVE_IS("ifdef") || DIRECTIVE_IS("ifndef");
+
+    if (lx->skip_depth > 0) {
+        if (opens) {
+            lx->skip_depth++;
+        } else if (DIRECTIVE_IS("endif")) {
+            lx->skip_depth--;
+            if (lx->skip_depth == 0) lx->skip_to_endif = 0;
+        } else if (lx->skip_depth == 1 && !lx->skip_to_endif &&
+                   (DIRECTIVE_IS("else") || (DIRECTIVE_IS("elif") && lex_constant_condition(lx) != 0))) {
+            // The alternative to '#if 0' is live.
+            lx->skip_depth = 0;
+            if (lx->cond_depth < MAX_COND_DEPTH) lx->conds[lx->cond_depth] = COND_OTHER;
+            lx->cond_depth++;
+        }
+        return;
+    }
+
+    if (DIRECTIVE_IS("if")) {
+        int constant = lex_constant_condition(lx);
+        if (constant == 0) {
+            lx->skip_depth = 1;
+            return;
+        }
+        if (lx->cond_depth < MAX_COND_DEPTH) lx->conds[lx->cond_depth] = constant == 1 ? COND_TRUE : COND_OTHER;
+        lx->cond_depth++;
+    } else if (opens) {
+        if (lx->cond_depth < MAX_COND_DEPTH) lx->conds[lx->cond_depth] = COND_OTHER;
+        lx->cond_depth++;
+        lex_skip_inline_space(lx);
+        while (lx->p < lx->end && is_ident_char(*lx->p)) lx->p++;
+    } else if (DIRECTIVE_IS("else") || DIRECTIVE_IS("elif")) {
+        if (lx->cond_depth > 0 && lx->cond_depth <= MAX_COND_DEPTH &&
+            lx->conds[lx->cond_depth - 1] == COND_TRUE) {
+            // Everything after '#if 1' up to its '#endif' is dead.
+            lx->cond_depth--;
+            lx->skip_depth = 1;
+            lx->skip_to_endif = 1;
+        }
+    } else if (DIRECTIVE_IS("endif")) {
+        if (lx->cond_depth > 0) lx->cond_depth--;
+    } else if (DIRECTIVE_IS("define") || DIRECTIVE_IS("undef")) {
+        // The macro name operand is not a use, e.g. the generated
+        // '#define REGISTER_COUNTER(name, ...)'. A define's body is scanned as usual.
+        lex_skip_inline_space(lx);
+        while (lx->p < lx->end && is_ident_char(*lx->p)) lx->p++;
+    } else if (DIRECTIVE_IS("include") && lx->includes) {
+        // Recorded with their opening delimiter ('"' or '<') as the first
+        // character, since the two forms are resolved differently.
+        lex_skip_inline_space(lx);
+        if (lx->p < lx->end && (*lx->p == '"' || *lx->p == '<')) {
+            char open = *lx->p;
+            char close = open == '<' ? '>' : '"';
+            const char* start = ++lx->p;
+            while (lx->p < lx->end && *lx->p != close && *lx->p != '\n') lx->p++;
+            if (lx->p < lx->end && *lx->p == close && lx->p > start && lx->p - start < MAX_PATH_LEN - 1) {
+                char include_name[MAX_PATH_LEN];
+                include_name[0] = open;
+                memcpy(include_name + 1, start, (size_t)(lx->p - start));
+                include_name[lx->p - start + 1] = '\0';
+                name_list_push(lx->includes, include_name);
+                lx->p++;
+            }
+        }
+    }
+#undef DIRECTIVE_IS
+}
+
+// Scans a NUL-terminated buffer. Markers are recorded when 'record_markers'
+// is set; includes are collected when 'includes' is non-NULL.
+static void scan_buffer(const char* buffer, size_t size, const char* filepath,
+                        int record_markers, NameList* includes) {
+    size_t std_len = strlen(g_marker_std);
+    size_t unique_len = strlen(g_marker_unique);
+
+    // Most files contain no marker at all; strstr is much cheaper than lexing.
+    if (!includes && (!record_markers ||
+        (!strstr(buffer, g_marker_std) && !strstr(buffer, g_marker_unique)))) {
+        return;
+    }
+
+    Lexer lx = {0};
+    lx.p = buffer;
+    lx.end = buffer + size;
+    lx.filepath = filepath;
+    lx.line = 1;
+    lx.at_line_start = 1;
+    lx.includes = includes;
+
+    while (lx.p < lx.end) {
+        char c = *lx.p;
+        if (c == '\n') {
+            lex_newline(&lx);
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            lx.p++;
+            continue;
+        }
+        if (c == '\\' && lx.p + 1 < lx.end && lx.p[1] == '\n') {
+            lx.p += 2;
+            lx.line++;
+            continue;
+        }
+        if (c == '/' && lx.p + 1 < lx.end && lx.p[1] == '/') {
+            lex_skip_line_comment(&lx);
+            continue;
+        }
+        if (c == '/' && lx.p + 1 < lx.end && lx.p[1] == '*') {
+            lex_skip_block_comment(&lx);
+            continue;
+        }
+        if (c == '#' && lx.at_line_start) {
+            lx.p++;
+            lx.at_line_start = 0;
+            lx.in_directive = 1;
+            lex_directive(&lx);
+            continue;
+        }
+        lx.at_line_start = 0;
+
+        // Dead groups are tokenized like live code, as the preprocessor does,
+        // so a "/*" inside a string cannot open a comment. An unmatched
+        // apostrophe in prose only runs to the end of its line.
+        int live = lx.skip_depth == 0 && record_markers;
+
+        if (c == '"' || c == '\'') {
+            lex_skip_quoted(&lx, c);
+        } else if (c >= '0' && c <= '9') {
+            // pp-number, including digit separators and signed exponents.
+            lx.p++;
+            while (lx.p < lx.end) {
+                char n = *lx.p;
+                if ((n == '+' || n == '-') && (lx.p[-1] == 'e' || lx.p[-1] == 'E' ||
+                                               lx.p[-1] == 'p' || lx.p[-1] == 'P')) lx.p++;
+                else if (is_ident_char(n) || n == '.' || n == '\'') lx.p++;
+                else break;
+            }
+        } else if (is_ident_start(c)) {
+            const char* start = lx.p;
+            while (lx.p < lx.end && is_ident_char(*lx.p)) lx.p++;
+            size_t len = (size_t)(lx.p - start);
+
+            if (lx.p < lx.end && *lx.p == '"' && is_raw_string_prefix(start, len)) {
+                lex_skip_raw_string(&lx);
+            } else if (live && len == std_len && memcmp(start, g_marker_std, len) == 0) {
+                lex_marker_call(&lx, 0, lx.line);
+            } else if (live && len == unique_len && memcmp(start, g_marker_unique, len) == 0) {
+                lex_marker_call(&lx, 1, lx.line);
+            }
+        } else {
+            lx.p++;
+        }
+    }
+}
+
+static int is_absolute_path(const char* path);
+
+// Returns 'path' relative to the project root (the working directory) when
+// it lies inside it, so absolute paths from a compilation database hash the
+// same on machines with different checkout locations.
+static const char* project_relative_path(const char* path, char* buffer) {
+    if (!is_absolute_path(path)) return path;
+    if (g_project_root[0] == '\0' && !canonicalize_path(".", g_project_root)) return path;
+
+    const char* candidates[2] = {path, NULL};
+    if (canonicalize_path(path, buffer)) candidates[1] = buffer;
+    size_t root_len = strlen(g_project_root);
+    for (int i = 0; i < 2; ++i) {
+        const char* candidate = candidates[i];
+        if (!candidate || strncmp(candidate, g_project_root, root_len) != 0) continue;
+        const char* rest = candidate + root_len;
+        if (*rest == '/' || *rest == '\\') return rest + 1;
+        if (*rest == '\0' || rest[-1] == '/' || rest[-1] == '\\') return rest;
+    }
+    return path;
+}
+
+// Every process numbers files in traversal order, whether or not it scans
+// them, so partials from different shards can be merged back into that order.
+static int begin_file(const char *filepath) {
+    g_current_file_seq = g_file_seq_count++;
+    if (g_shard_count == 0) return 1;
+    char buffer[MAX_PATH_LEN];
+    return hash_string(project_relative_path(filepath, buffer)) % g_shard_count == g_shard_index;
+}
+
+void process_file(const char *filepath) {
+    if (!mark_file_visited(filepath)) return;
+    if (!begin_file(filepath)) return;
+    size_t size = 0;
+    char* buffer = read_entire_file(filepath, &size);
+    if (!buffer) return;
+    scan_buffer(buffer, size, filepath, 1, NULL);
+    free(buffer);
 }
 
 void process_path(const char *path) {
@@ -195,6 +695,351 @@ void process_path(const char *path) {
     }
 }
 
+// --- Targeted Inputs (compile_commands.json, NUL-separated lists) ---
+
+typedef struct {
+    const char* directory;
+    const char* include_dirs[MAX_INCLUDE_DIRS];
+    size_t include_count;
+} CompdbEntry;
+
+typedef struct {
+    char* p;
+    char* end;
+} JsonCursor;
+
+static int is_absolute_path(const char* path) {
+#ifdef _WIN32
+    if (path[0] && path[1] == ':') return 1;
+    if (path[0] == '\\') return 1;
+#endif
+    return path[0] == '/';
+}
+
+// Returns 0 if the joined path does not fit in MAX_PATH_LEN.
+static int join_path(char* out, const char* dir, const char* name) {
+    int written;
+    if (is_absolute_path(name) || !dir || dir[0] == '\0') {
+        written = snprintf(out, MAX_PATH_LEN, "%s", name);
+    } else {
+        written = snprintf(out, MAX_PATH_LEN, "%s/%s", dir, name);
+    }
+    return written >= 0 && written < MAX_PATH_LEN;
+}
+
+static void directory_of(char* out, const char* path) {
+    snprintf(out, MAX_PATH_LEN, "%s", path);
+    char* slash = strrchr(out, '/');
+    char* backslash = strrchr(out, '\\');
+    if (backslash > slash) slash = backslash;
+    if (slash) *slash = '\0';
+    else strcpy(out, ".");
+}
+
+static int is_in_project_tree(const char* path) {
+    char canonical[MAX_PATH_LEN];
+    if (g_project_root[0] == '\0' && !canonicalize_path(".", g_project_root)) return 0;
+    if (!canonicalize_path(path, canonical)) return 0;
+    size_t root_len = strlen(g_project_root);
+    if (strncmp(canonical, g_project_root, root_len) != 0) return 0;
+    return canonical[root_len] == '\0' || canonical[root_len] == '/' || canonical[root_len] == '\\' ||
+           (root_len > 0 && (g_project_root[root_len - 1] == '/' || g_project_root[root_len - 1] == '\\'));
+}
+
+// 'include' is a name recorded by the lexer: '"name' is looked up next to
+// the including file first, '<name' only in the entry's include directories.
+static int resolve_include(char* out, const char* includer, const char* include, const CompdbEntry* entry) {
+    char dir[MAX_PATH_LEN];
+    char base[MAX_PATH_LEN];
+    struct stat s;
+    const char* name = include + 1;
+
+    if (include[0] == '"') {
+        directory_of(dir, includer);
+        if (join_path(out, dir, name) && stat(out, &s) == 0 && (s.st_mode & S_IFREG)) return 1;
+    }
+
+    for (size_t i = 0; i < entry->include_count; ++i) {
+        if (!join_path(base, entry->directory, entry->include_dirs[i])) continue;
+        if (join_path(out, base, name) && stat(out, &s) == 0 && (s.st_mode & S_IFREG)) return 1;
+    }
+    return 0;
+}
+
+// Scans a translation unit listed in a compilation database and, when
+// 'compdb_headers' is enabled, the headers it reaches inside the project tree.
+// With 'compdb_headers', files whose extension is not in 'scan_ext' are still
+// read for their includes, but their markers are not recorded.
+static void process_compdb_file(const char* filepath, const CompdbEntry* entry) {
+    int scanned = has_valid_extension(filepath);
+    if (!scanned && !g_compdb_headers) return;
+    if (!mark_file_visited(filepath)) return;
+    // Files owned by another shard are still read for their includes so that
+    // all shards agree on which headers are reached, and in which order.
+    int owned = begin_file(filepath);
+    if (!(owned && scanned) && !g_compdb_headers) return;
+    size_t size = 0;
+    char* buffer = read_entire_file(filepath, &size);
+    if (!buffer) return;
+
+    NameList includes = {0};
+    scan_buffer(buffer, size, filepath, owned && scanned, g_compdb_headers ? &includes : NULL);
+    free(buffer);
+
+    char header_path[MAX_PATH_LEN];
+    for (size_t i = 0; i < includes.count; ++i) {
+        if (resolve_include(header_path, filepath, includes.items[i], entry) &&
+            is_in_project_tree(header_path)) {
+            process_compdb_file(header_path, entry);
+        }
+    }
+    name_list_free(&includes);
+}
+
+static void json_skip_ws(JsonCursor* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\r' || *c->p == '\n')) c->p++;
+}
+
+// Decodes a JSON string in place and returns it NUL-terminated. The decoded
+// form is never longer than the encoded one, so no allocation is needed.
+static char* json_parse_string(JsonCursor* c) {
+    if (c->p >= c->end || *c->p != '"') return NULL;
+    char* start = ++c->p;
+    char* out = start;
+    while (c->p < c->end && *c->p != '"') {
+        if (*c->p != '\\') {
+            *out++ = *c->p++;
+            continue;
+        }
+        if (++c->p >= c->end) return NULL;
+        char esc = *c->p++;
+        switch (esc) {
+            case 'n': *out++ = '\n'; break;
+            case 't': *out++ = '\t'; break;
+            case 'r': *out++ = '\r'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'u': {
+                if (c->end - c->p < 4) return NULL;
+                char hex[5] = {c->p[0], c->p[1], c->p[2], c->p[3], 0};
+                unsigned long cp = strtoul(hex, NULL, 16);
+                c->p += 4;
+                if (cp < 0x80) {
+                    *out++ = (char)cp;
+                } else if (cp < 0x800) {
+                    *out++ = (char)(0xC0 | (cp >> 6));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    *out++ = (char)(0xE0 | (cp >> 12));
+                    *out++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *out++ = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: *out++ = esc; break;
+        }
+    }
+    if (c->p >= c->end) return NULL;
+    c->p++;
+    *out = '\0';
+    return start;
+}
+
+static int json_skip_value(JsonCursor* c) {
+    json_skip_ws(c);
+    if (c->p >= c->end) return 0;
+    if (*c->p == '"') return json_parse_string(c) != NULL;
+    if (*c->p == '[' || *c->p == '{') {
+        int depth = 0;
+        while (c->p < c->end) {
+            if (*c->p == '"') {
+                if (!json_parse_string(c)) return 0;
+                continue;
+            }
+            if (*c->p == '[' || *c->p == '{') depth++;
+            else if (*c->p == ']' || *c->p == '}') {
+                if (--depth == 0) {
+                    c->p++;
+                    return 1;
+                }
+            }
+            c->p++;
+        }
+        return 0;
+    }
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']') c->p++;
+    return 1;
+}
+
+// Records include directories from one compiler argument. 'pending' carries
+// a bare '-I' over to the argument that follows it.
+static void collect_include_arg(CompdbEntry* entry, const char* arg, int* pending) {
+    const char* dir = NULL;
+    if (*pending) {
+        dir = arg;
+        *pending = 0;
+    } else if (strcmp(arg, "-I") == 0 || strcmp(arg, "/I") == 0 || strcmp(arg, "-iquote") == 0) {
+        *pending = 1;
+    } else if (strncmp(arg, "-I", 2) == 0 || strncmp(arg, "/I", 2) == 0) {
+        dir = arg + 2;
+    } else if (strncmp(arg, "-iquote", 7) == 0) {
+        dir = arg + 7;
+    }
+    if (dir && dir[0] && entry->include_count < MAX_INCLUDE_DIRS) {
+        entry->include_dirs[entry->include_count++] = dir;
+    }
+}
+
+// Splits a shell-style command line in place, honouring simple quoting.
+static void collect_include_args_from_command(CompdbEntry* entry, char* command) {
+    int pending = 0;
+    char* p = command;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+        char* token = p;
+        char* out = p;
+        char quote = 0;
+        while (*p && (quote || (*p != ' ' && *p != '\t'))) {
+            if (quote && *p == quote) { quote = 0; p++; continue; }
+            if (!quote && (*p == '"' || *p == '\'')) { quote = *p++; continue; }
+            if (*p == '\\' && p[1] && quote != '\'') p++;
+            *out++ = *p++;
+        }
+        if (*p) p++;
+        *out = '\0';
+        collect_include_arg(entry, token, &pending);
+    }
+}
+
+void process_compile_commands(const char* compdb_path) {
+    size_t size = 0;
+    char* buffer = read_entire_file(compdb_path, &size);
+    if (!buffer) {
+        fprintf(stderr, "FATAL: Cannot read compilation database '%s'\n", compdb_path);
+        exit(1);
+    }
+
+    JsonCursor c = {buffer, buffer + size};
+    json_skip_ws(&c);
+    if (c.p >= c.end || *c.p != '[') goto malformed;
+    c.p++;
+
+    for (;;) {
+        json_skip_ws(&c);
+        if (c.p < c.end && *c.p == ',') { c.p++; json_skip_ws(&c); }
+        if (c.p >= c.end) goto malformed;
+        if (*c.p == ']') break;
+        if (*c.p != '{') goto malformed;
+        c.p++;
+
+        CompdbEntry entry = {0};
+        const char* file = NULL;
+        int pending = 0;
+
+        for (;;) {
+            json_skip_ws(&c);
+            if (c.p < c.end && *c.p == ',') { c.p++; json_skip_ws(&c); }
+            if (c.p >= c.end) goto malformed;
+            if (*c.p == '}') { c.p++; break; }
+
+            char* key = json_parse_string(&c);
+            if (!key) goto malformed;
+            json_skip_ws(&c);
+            if (c.p >= c.end || *c.p != ':') goto malformed;
+            c.p++;
+            json_skip_ws(&c);
+
+            if (strcmp(key, "directory") == 0) {
+                if (!(entry.directory = json_parse_string(&c))) goto malformed;
+            } else if (strcmp(key, "file") == 0) {
+                if (!(file = json_parse_string(&c))) goto malformed;
+            } else if (strcmp(key, "command") == 0) {
+                char* command = json_parse_string(&c);
+                if (!command) goto malformed;
+                if (g_compdb_headers) collect_include_args_from_command(&entry, command);
+            } else if (strcmp(key, "arguments") == 0 && c.p < c.end && *c.p == '[') {
+                c.p++;
+                for (;;) {
+                    json_skip_ws(&c);
+                    if (c.p < c.end && *c.p == ',') { c.p++; json_skip_ws(&c); }
+                    if (c.p >= c.end) goto malformed;
+                    if (*c.p == ']') { c.p++; break; }
+                    char* arg = json_parse_string(&c);
+                    if (!arg) goto malformed;
+                    collect_include_arg(&entry, arg, &pending);
+                }
+            } else if (!json_skip_value(&c)) {
+                goto malformed;
+            }
+        }
+
+        if (file) {
+            char tu_path[MAX_PATH_LEN];
+            if (join_path(tu_path, entry.directory, file)) {
+                process_compdb_file(tu_path, &entry);
+            }
+        }
+    }
+
+    free(buffer);
+    return;
+
+malformed:
+    fprintf(stderr, "FATAL: Malformed compilation database '%s'\n", compdb_path);
+    free(buffer);
+    exit(1);
+}
+
+static void process_stdin_entry(char* path, size_t len, int too_long) {
+    if (len == 0) return;
+    path[len] = '\0';
+    if (too_long) {
+        fprintf(stderr, "[WARN] Skipping stdin entry longer than %d bytes: '%.64s...'\n",
+                MAX_PATH_LEN - 1, path);
+        return;
+    }
+    process_path(path);
+}
+
+// Reads a NUL-separated path list from stdin, as produced by 'git ls-files -z'.
+// Only NUL separates entries, so names containing newlines are preserved.
+void process_stdin_list(void) {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    char path[MAX_PATH_LEN];
+    size_t len = 0;
+    int too_long = 0;
+    int ch;
+    while ((ch = getchar()) != EOF) {
+        if (ch == '\0') {
+            process_stdin_entry(path, len, too_long);
+            len = 0;
+            too_long = 0;
+        } else if (len < sizeof(path) - 1) {
+            path[len++] = (char)ch;
+        } else {
+            too_long = 1;
+        }
+    }
+    process_stdin_entry(path, len, too_long);
+}
+
+static int is_compile_commands(const char* path) {
+    const char* base = path;
+    for (const char* p = path; *p; ++p) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    return strcmp(base, COMPDB_FILENAME) == 0;
+}
+
+void process_source_entry(const char* entry) {
+    if (strcmp(entry, "-") == 0) process_stdin_list();
+    else if (is_compile_commands(entry)) process_compile_commands(entry);
+    else process_path(entry);
+}
+
 void trim(char *str) {
     char *start = str;
     while (*start == ' ' || *start == '\t' || *start == '\r' || *start == '\n') {
@@ -235,12 +1080,28 @@ static void handle_marker_unique(const char* value) {
     strncpy(g_marker_unique, value, sizeof(g_marker_unique) - 1);
 }
 
+static void handle_module_file(const char* value) {
+    strncpy(g_module_file, value, sizeof(g_module_file) - 1);
+}
+static void handle_module_name(const char* value) {
+    strncpy(g_module_name, value, sizeof(g_module_name) - 1);
+}
+
+static void handle_output_mode(const char* value) {
+    if (strcmp(value, "module") == 0) g_output_mode = OUTPUT_MODULE;
+    else g_output_mode = OUTPUT_HEADER;
+}
+
 static void handle_duplicate_policy(const char* value) {
     if (strcmp(value, "warn") == 0) g_policy = POLICY_WARN;
     else if (strcmp(value, "error") == 0) g_policy = POLICY_ERROR;
     else g_policy = POLICY_IGNORE;
 }
 
+static void handle_compdb_headers(const char* value) {
+    g_compdb_headers = (strcmp(value, "yes") == 0 || strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+}
+
 static void handle_scan_ext(const char* value) {
     char* value_copy = arena_strdup(&g_main_arena, value);
     char* ext = strtok(value_copy, " ");
@@ -257,7 +1118,11 @@ static const ConfigHandler g_config_handlers[] = {
     {"marker_standard",  handle_marker_std},
     {"marker_unique",    handle_marker_unique},
     {"duplicate_policy", handle_duplicate_policy},
-    {"scan_ext",         handle_scan_ext}
+    {"scan_ext",         handle_scan_ext},
+    {"compdb_headers",   handle_compdb_headers},
+    {"output_mode",      handle_output_mode},
+    {"module_file",      handle_module_file},
+    {"module_name",      handle_module_name}
 };
 static const size_t g_num_config_handlers = sizeof(g_config_handlers) / sizeof(g_config_handlers[0]);
 
@@ -328,24 +1193,35 @@ static void write_enum_entries(OutputContext* ctx, const char* prefix,
             ctx->max_value + 1);
 }
 
-static void write_name_array(OutputContext* ctx) {
-    fprintf(ctx->file, "    static const char* names[] = {\n");
+static void write_name_entries(OutputContext* ctx, const char* indent) {
     for (int i = 0; i <= ctx->max_value; ++i) {
         int found = 0;
         for (size_t j = 0; j < ctx->count; ++j) {
             if (ctx->identifiers[j].value == i) {
-                fprintf(ctx->file, "        \"%s\",\n", ctx->identifiers[j].name);
+                fprintf(ctx->file, "%s\"%s\",\n", indent, ctx->identifiers[j].name);
                 found = 1;
                 break;
             }
         }
         if (!found) {
-            fprintf(ctx->file, "        \"(unused)\",\n");
+            fprintf(ctx->file, "%s\"(unused)\",\n", indent);
         }
     }
+}
+
+static void write_name_array(OutputContext* ctx) {
+    fprintf(ctx->file, "    static const char* names[] = {\n");
+    write_name_entries(ctx, "        ");
     fprintf(ctx->file, "    };\n");
 }
 
+static void write_cpp_macros(OutputContext* ctx) {
+    fprintf(ctx->file, "#define %s(name, ...) %s::name\n",
+            ctx->marker_std, ctx->enum_name);
+    fprintf(ctx->file, "#define %s(name, ...) %s::name\n\n",
+            ctx->marker_unique, ctx->enum_name);
+}
+
 static void write_cpp_section(OutputContext* ctx) {
     fprintf(ctx->file, "#ifdef __cplusplus\n\n");
     
@@ -368,10 +1244,47 @@ static void write_cpp_section(OutputContext* ctx) {
     fprintf(ctx->file, "}\n\n");
     
     // Macros
-    fprintf(ctx->file, "#define %s(name, ...) %s::name\n",
-            ctx->marker_std, ctx->enum_name);
-    fprintf(ctx->file, "#define %s(name, ...) %s::name\n\n",
-            ctx->marker_unique, ctx->enum_name);
+    write_cpp_macros(ctx);
+}
+
+// Companion-header C++ section for module mode: macros cannot be exported
+// from a module, so the header imports it and keeps only the macros.
+static void write_cpp_import_section(OutputContext* ctx) {
+    fprintf(ctx->file, "#ifdef __cplusplus\n\n");
+    fprintf(ctx->file, "import %s;\n\n", ctx->module_name);
+    write_cpp_macros(ctx);
+}
+
+// C++20 module interface unit. It is compiled once into a BMI plus an object
+// file, so the lookup function is an ordinary (non-inline) definition.
+static void write_module_interface(OutputContext* ctx) {
+    fprintf(ctx->file, "// THIS FILE IS AUTO-GENERATED BY METACOUNTER. DO NOT EDIT.\n");
+    fprintf(ctx->file, "module;\n\n");
+    fprintf(ctx->file, "#include <stdint.h>\n\n");
+    fprintf(ctx->file, "export module %s;\n\n", ctx->module_name);
+
+    // Enum class
+    fprintf(ctx->file, "export enum class %s : uint32_t {\n", ctx->enum_name);
+    write_enum_entries(ctx, NULL, NULL);
+    fprintf(ctx->file, "};\n\n");
+
+    // Constant. Namespace-scope constexpr alone means internal linkage, which
+    // cannot be exported.
+    fprintf(ctx->file, "export inline constexpr uint32_t %s_INT = %d;\n\n",
+            ctx->count_name, ctx->max_value + 1);
+
+    // Name table
+    fprintf(ctx->file, "export inline constexpr const char* %s_names[] = {\n", ctx->enum_name);
+    write_name_entries(ctx, "    ");
+    fprintf(ctx->file, "};\n\n");
+
+    // Name lookup function
+    fprintf(ctx->file, "export const char* get_name_for_%s(%s id) {\n",
+            ctx->enum_name, ctx->enum_name);
+    fprintf(ctx->file, "    if ((uint32_t)id <= %d) return %s_names[(uint32_t)id];\n",
+            ctx->max_value, ctx->enum_name);
+    fprintf(ctx->file, "    return \"(invalid)\";\n");
+    fprintf(ctx->file, "}\n");
 }
 
 static void write_c_section(OutputContext* ctx) {
@@ -403,73 +1316,63 @@ static void write_c_section(OutputContext* ctx) {
     fprintf(ctx->file, "#endif\n");
 }
 
-static void generate_output_file(const char* filename,
-                                const IdentifierInfo* identifiers,
-                                size_t count, int max_value) {
+static FILE* open_output_file(const char* filename) {
     FILE* file = fopen(filename, "w");
     if (!file) {
         fprintf(stderr, "FATAL: Cannot open output file '%s'\n", filename);
         exit(1);
     }
-    
+    return file;
+}
+
+static void generate_output_file(const char* filename,
+                                const IdentifierInfo* identifiers,
+                                size_t count, int max_value) {
     OutputContext ctx = {
-        .file = file,
+        .file = NULL,
         .enum_name = g_enum_name,
         .count_name = g_count_name,
         .marker_std = g_marker_std,
         .marker_unique = g_marker_unique,
+        .module_name = g_module_name,
         .identifiers = identifiers,
         .count = count,
         .max_value = max_value
     };
     
+    if (g_output_mode == OUTPUT_MODULE) {
+        ctx.file = open_output_file(g_module_file);
+        write_module_interface(&ctx);
+        fclose(ctx.file);
+    }
+
+    ctx.file = open_output_file(filename);
     write_header(&ctx);
-    write_cpp_section(&ctx);
+    if (g_output_mode == OUTPUT_MODULE) write_cpp_import_section(&ctx);
+    else write_cpp_section(&ctx);
     write_c_section(&ctx);
     
-    fclose(file);
+    fclose(ctx.file);
 }
 
-// --- Main Function ---
-
-int main(int argc, char *argv[]) {
-    arena_init(&g_main_arena, 64 * 1024 * 1024);
-    atexit((void(*)(void))arena_free);
-
-    const char *config_path = (argc > 1) ? argv[1] : CONFIG_FILENAME;
-    
-    parse_config(config_path);
+// Returns 1 if the config names everything generate_output_file() needs.
+static int check_output_config(void) {
     if (g_output_file[0] == 0) {
         fprintf(stderr, "FATAL: 'output_file' not set in config.\n");
-        return 1;
+        return 0;
     }
-    if (g_ext_count == 0) {
-        fprintf(stderr, "FATAL: 'scan_ext' not set in config.\n");
-        return 1;
+    if (g_output_mode == OUTPUT_MODULE && g_module_file[0] == 0) {
+        fprintf(stderr, "FATAL: 'module_file' not set in config (required by 'output_mode: module').\n");
+        return 0;
     }
+    return 1;
+}
 
-    remove(g_output_file);
-
-    FILE *config_file = fopen(config_path, "r");
-    char line[MAX_LINE_LEN];
-    int in_sources_block = 0;
-    while (fgets(line, sizeof(line), config_file)) {
-        trim(line);
-        if (line[0] == '\0' || line[0] == '#') continue;
-        if (strcmp(line, "begin_sources") == 0) {
-            in_sources_block = 1;
-            continue;
-        }
-        if (strcmp(line, "end_sources") == 0) {
-            in_sources_block = 0;
-            continue;
-        }
-        if (in_sources_block) {
-            process_path(line);
-        }
-    }
-    fclose(config_file);
+// --- Identifier Resolution ---
 
+// Applies the duplicate/unique rules and assigns values. Returns 1 if any
+// error-level conflict was found.
+static int resolve_identifiers(IdentifierInfo** out_list, size_t* out_count, int* out_max_value) {
     IdentifierInfo *final_list = arena_alloc(&g_main_arena, g_id_count * sizeof(IdentifierInfo));
     size_t final_count = 0;
     int error_found = 0;
@@ -524,7 +1427,331 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    if (error_found) {
+    *out_list = final_list;
+    *out_count = final_count;
+    *out_max_value = max_value;
+    return error_found;
+}
+
+static void scan_sources(const char* config_path) {
+    FILE *config_file = fopen(config_path, "r");
+    char line[MAX_LINE_LEN];
+
+    // Files can only be reached twice through several entries, a stdin list
+    // or a compilation database; a single directory or file needs no
+    // visited set.
+    for (int pass = 0; pass < 2; ++pass) {
+        int in_sources_block = 0;
+        int entry_count = 0;
+        rewind(config_file);
+        while (fgets(line, sizeof(line), config_file)) {
+            trim(line);
+            if (line[0] == '\0' || line[0] == '#') continue;
+            if (strcmp(line, "begin_sources") == 0) {
+                in_sources_block = 1;
+                continue;
+            }
+            if (strcmp(line, "end_sources") == 0) {
+                in_sources_block = 0;
+                continue;
+            }
+            if (!in_sources_block) continue;
+            if (pass == 0) {
+                entry_count++;
+                if (strcmp(line, "-") == 0 || is_compile_commands(line)) g_dedupe_files = 1;
+            } else {
+                process_source_entry(line);
+            }
+        }
+        if (pass == 0 && entry_count > 1) g_dedupe_files = 1;
+    }
+    fclose(config_file);
+    free_visited_files();
+}
+
+// --- Partial Results (sharded scanning) ---
+//
+// Layout, all integers little-endian u32:
+//   magic[8] shard_index shard_count file_total file_count id_count
+//   file_count x { file_seq path_len path[path_len] }
+//   id_count   x { file_index line value is_unique(u8) name_len name[name_len] }
+
+static void write_u32(FILE* file, unsigned int v) {
+    unsigned char bytes[4] = {
+        (unsigned char)(v & 0xFF), (unsigned char)((v >> 8) & 0xFF),
+        (unsigned char)((v >> 16) & 0xFF), (unsigned char)((v >> 24) & 0xFF)
+    };
+    fwrite(bytes, 1, 4, file);
+}
+
+static void write_bytes(FILE* file, const char* s) {
+    size_t len = strlen(s);
+    write_u32(file, (unsigned int)len);
+    fwrite(s, 1, len, file);
+}
+
+static void write_partial(const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "FATAL: Cannot open partial file '%s'\n", filename);
+        exit(1);
+    }
+
+    // Identifiers are recorded file by file, so each run of equal file_seq
+    // becomes one file table entry.
+    unsigned int file_count = 0;
+    for (size_t i = 0; i < g_id_count; ++i) {
+        if (i == 0 || g_identifiers[i].file_seq != g_identifiers[i - 1].file_seq) file_count++;
+    }
+
+    fwrite(PARTIAL_MAGIC, 1, 8, file);
+    write_u32(file, g_shard_index);
+    write_u32(file, g_shard_count);
+    write_u32(file, (unsigned int)g_file_seq_count);
+    write_u32(file, file_count);
+    write_u32(file, (unsigned int)g_id_count);
+
+    for (size_t i = 0; i < g_id_count; ++i) {
+        if (i == 0 || g_identifiers[i].file_seq != g_identifiers[i - 1].file_seq) {
+            write_u32(file, (unsigned int)g_identifiers[i].file_seq);
+            write_bytes(file, g_identifiers[i].filepath);
+        }
+    }
+
+    unsigned int file_index = 0;
+    for (size_t i = 0; i < g_id_count; ++i) {
+        if (i > 0 && g_identifiers[i].file_seq != g_identifiers[i - 1].file_seq) file_index++;
+        write_u32(file, file_index);
+        write_u32(file, (unsigned int)g_identifiers[i].line_num);
+        write_u32(file, (unsigned int)g_identifiers[i].value);
+        fputc(g_identifiers[i].is_unique_request ? 1 : 0, file);
+        write_bytes(file, g_identifiers[i].name);
+    }
+
+    if (fclose(file) != 0) {
+        fprintf(stderr, "FATAL: Failed to write partial file '%s'\n", filename);
+        exit(1);
+    }
+}
+
+typedef struct {
+    const char* filename;
+    const unsigned char* p;
+    const unsigned char* end;
+} PartialReader;
+
+static void partial_fail(const PartialReader* r) {
+    fprintf(stderr, "FATAL: Partial file '%s' is truncated or corrupt.\n", r->filename);
+    exit(1);
+}
+
+static unsigned int read_u32(PartialReader* r) {
+    if (r->end - r->p < 4) partial_fail(r);
+    unsigned int v = (unsigned int)r->p[0] | ((unsigned int)r->p[1] << 8) |
+                     ((unsigned int)r->p[2] << 16) | ((unsigned int)r->p[3] << 24);
+    r->p += 4;
+    return v;
+}
+
+static char* read_bytes(PartialReader* r) {
+    unsigned int len = read_u32(r);
+    if ((size_t)(r->end - r->p) < len) partial_fail(r);
+    char* s = arena_alloc(&g_main_arena, (size_t)len + 1);
+    if (!s) partial_fail(r);
+    memcpy(s, r->p, len);
+    s[len] = '\0';
+    r->p += len;
+    return s;
+}
+
+// Restores traversal order across shards. A counting sort on file_seq is
+// stable, so identifiers keep their in-file order.
+static void sort_identifiers_by_file(int file_total) {
+    size_t* offsets = arena_alloc(&g_main_arena, ((size_t)file_total + 1) * sizeof(size_t));
+    IdentifierInfo* sorted = arena_alloc(&g_main_arena, g_id_count * sizeof(IdentifierInfo));
+    if (!offsets || (g_id_count > 0 && !sorted)) {
+        fprintf(stderr, "FATAL: Not enough memory to merge %d files.\n", file_total);
+        exit(1);
+    }
+    memset(offsets, 0, ((size_t)file_total + 1) * sizeof(size_t));
+    for (size_t i = 0; i < g_id_count; ++i) offsets[g_identifiers[i].file_seq + 1]++;
+    for (int f = 0; f < file_total; ++f) offsets[f + 1] += offsets[f];
+    for (size_t i = 0; i < g_id_count; ++i) sorted[offsets[g_identifiers[i].file_seq]++] = g_identifiers[i];
+    g_identifiers = sorted;
+}
+
+static int run_merge(const char* config_path, int partial_count, char** partial_paths) {
+    parse_config(config_path);
+    if (!check_output_config()) {
+        return 1;
+    }
+    if (partial_count == 0) {
+        fprintf(stderr, "FATAL: 'merge' needs at least one partial file.\n");
+        return 1;
+    }
+
+    unsigned int shard_count = 0;
+    unsigned int file_total = 0;
+    unsigned char* seen = NULL;
+
+    for (int i = 0; i < partial_count; ++i) {
+        size_t size = 0;
+        char* buffer = read_entire_file(partial_paths[i], &size);
+        if (!buffer) {
+            fprintf(stderr, "FATAL: Cannot open partial file '%s'\n", partial_paths[i]);
+            return 1;
+        }
+        PartialReader r = {partial_paths[i], (const unsigned char*)buffer, (const unsigned char*)buffer + size};
+        if (size < 8 || memcmp(buffer, PARTIAL_MAGIC, 8) != 0) partial_fail(&r);
+        r.p += 8;
+
+        unsigned int shard_index = read_u32(&r);
+        unsigned int this_shard_count = read_u32(&r);
+        unsigned int this_file_total = read_u32(&r);
+        if (this_file_total > INT_MAX) partial_fail(&r);
+        if (i == 0) {
+            shard_count = this_shard_count;
+            file_total = this_file_total;
+            seen = arena_alloc(&g_main_arena, shard_count);
+            if (!seen) partial_fail(&r);
+            memset(seen, 0, shard_count);
+        }
+        if (this_shard_count != shard_count || shard_index >= shard_count) {
+            fprintf(stderr, "FATAL: Partial '%s' is shard %u/%u, expected one of %u shards.\n",
+                    partial_paths[i], shard_index, this_shard_count, shard_count);
+            return 1;
+        }
+        if (this_file_total != file_total) {
+            fprintf(stderr, "FATAL: Partial '%s' walked %u files, others walked %u; "
+                            "shards must scan the same tree with the same config.\n",
+                    partial_paths[i], this_file_total, file_total);
+            return 1;
+        }
+        if (seen[shard_index]) {
+            fprintf(stderr, "FATAL: Shard %u/%u given more than once.\n", shard_index, shard_count);
+            return 1;
+        }
+        seen[shard_index] = 1;
+
+        unsigned int file_count = read_u32(&r);
+        unsigned int id_count = read_u32(&r);
+        // Each file entry takes at least 8 bytes and each identifier at least
+        // 17, so larger counts cannot be backed by the rest of the file.
+        size_t remaining = (size_t)(r.end - r.p);
+        if (file_count > remaining / 8 || id_count > remaining / 17) partial_fail(&r);
+        int* file_seqs = arena_alloc(&g_main_arena, (size_t)file_count * sizeof(int) + 1);
+        char** file_paths = arena_alloc(&g_main_arena, (size_t)file_count * sizeof(char*) + 1);
+        if (!file_seqs || !file_paths) partial_fail(&r);
+        for (unsigned int f = 0; f < file_count; ++f) {
+            file_seqs[f] = (int)read_u32(&r);
+            if ((unsigned int)file_seqs[f] >= file_total) partial_fail(&r);
+            file_paths[f] = read_bytes(&r);
+        }
+        for (unsigned int n = 0; n < id_count; ++n) {
+            unsigned int file_index = read_u32(&r);
+            int line_num = (int)read_u32(&r);
+            int value = (int)read_u32(&r);
+            if (r.p >= r.end) partial_fail(&r);
+            int is_unique = *r.p++;
+            char* name = read_bytes(&r);
+            if (file_index >= file_count) partial_fail(&r);
+            g_current_file_seq = file_seqs[file_index];
+            add_identifier(name, file_paths[file_index], line_num, is_unique, value);
+        }
+        free(buffer);
+    }
+
+    if ((unsigned int)partial_count != shard_count) {
+        fprintf(stderr, "FATAL: Got %d partials for %u shards.\n", partial_count, shard_count);
+        return 1;
+    }
+
+    sort_identifiers_by_file((int)file_total);
+
+    IdentifierInfo* final_list = NULL;
+    size_t final_count = 0;
+    int max_value = -1;
+    if (resolve_identifiers(&final_list, &final_count, &max_value)) {
+        return 1;
+    }
+
+    generate_output_file(g_output_file, final_list, final_count, max_value);
+
+    printf("Metacounter: Success! Merged %d partials, wrote %zu identifiers to %s.\n",
+           partial_count, final_count, g_output_file);
+    return 0;
+}
+
+// --- Main Function ---
+
+int main(int argc, char *argv[]) {
+    arena_init(&g_main_arena, 64 * 1024 * 1024);
+    atexit((void(*)(void))arena_free);
+
+    if (argc > 1 && strcmp(argv[1], "merge") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: metacounter merge <config> <partial>...\n");
+            return 1;
+        }
+        return run_merge(argv[2], argc - 3, argv + 3);
+    }
+
+    const char *config_path = CONFIG_FILENAME;
+    const char *partial_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--shard") == 0) {
+            const char* value = (i + 1 < argc) ? argv[++i] : "";
+            char trailing;
+            if (sscanf(value, "%u/%u%c", &g_shard_index, &g_shard_count, &trailing) != 2 ||
+                g_shard_count == 0 || g_shard_index >= g_shard_count) {
+                fprintf(stderr, "FATAL: '--shard' expects i/N with 0 <= i < N, got '%s'.\n", value);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--partial") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "FATAL: '--partial' expects a file path.\n");
+                return 1;
+            }
+            partial_path = argv[++i];
+        } else {
+            config_path = argv[i];
+        }
+    }
+
+    parse_config(config_path);
+    if (!check_output_config()) {
+        return 1;
+    }
+    if (g_ext_count == 0) {
+        fprintf(stderr, "FATAL: 'scan_ext' not set in config.\n");
+        return 1;
+    }
+
+    // A shard only writes a partial, so it leaves the current header alone;
+    // the lexer ignores the generated '#define' lines if the header is scanned.
+    if (g_shard_count == 0) {
+        remove(g_output_file);
+    }
+
+    scan_sources(config_path);
+
+    if (g_shard_count > 0) {
+        char default_partial[MAX_LINE_LEN + 32];
+        if (!partial_path) {
+            snprintf(default_partial, sizeof(default_partial), "%s.%u-of-%u.partial",
+                     g_output_file, g_shard_index, g_shard_count);
+            partial_path = default_partial;
+        }
+        write_partial(partial_path);
+        printf("Metacounter: Wrote shard %u/%u (%zu identifiers) to %s.\n",
+               g_shard_index, g_shard_count, g_id_count, partial_path);
+        return 0;
+    }
+
+    IdentifierInfo* final_list = NULL;
+    size_t final_count = 0;
+    int max_value = -1;
+    if (resolve_identifiers(&final_list, &final_count, &max_value)) {
         return 1;
     }
 
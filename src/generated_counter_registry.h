@@ -6,13 +6,13 @@
 #ifdef __cplusplus
 
 enum class CounterID : uint32_t {
-    PlayerHealth = 0,
-    PlayerStamina = 1,
-    DrawCalls = 2,
-    ShaderBinds = 3,
-    TextureBinds = 4,
-    MainRenderContext = 5,
-    ActiveAudioChannels = 6,
+    ActiveAudioChannels = 0,
+    DrawCalls = 1,
+    ShaderBinds = 2,
+    TextureBinds = 3,
+    MainRenderContext = 4,
+    PlayerHealth = 5,
+    PlayerStamina = 6,
     MAX_COUNT = 7
 };
 
@@ -20,13 +20,13 @@ constexpr uint32_t MAX_COUNT_INT = 7;
 
 inline const char* get_name_for_CounterID(CounterID id) {
     static const char* names[] = {
-        "PlayerHealth",
-        "PlayerStamina",
+        "ActiveAudioChannels",
         "DrawCalls",
         "ShaderBinds",
         "TextureBinds",
         "MainRenderContext",
-        "ActiveAudioChannels",
+        "PlayerHealth",
+        "PlayerStamina",
     };
     if ((uint32_t)id <= 6) return names[(uint32_t)id];
     return "(invalid)";
@@ -38,13 +38,13 @@ inline const char* get_name_for_CounterID(CounterID id) {
 #else
 
 typedef enum {
-    CounterID_PlayerHealth = 0,
-    CounterID_PlayerStamina = 1,
-    CounterID_DrawCalls = 2,
-    CounterID_ShaderBinds = 3,
-    CounterID_TextureBinds = 4,
-    CounterID_MainRenderContext = 5,
-    CounterID_ActiveAudioChannels = 6,
+    CounterID_ActiveAudioChannels = 0,
+    CounterID_DrawCalls = 1,
+    CounterID_ShaderBinds = 2,
+    CounterID_TextureBinds = 3,
+    CounterID_MainRenderContext = 4,
+    CounterID_PlayerHealth = 5,
+    CounterID_PlayerStamina = 6,
     CounterID_MAX_COUNT = 7
 } CounterID;
 
@@ -52,13 +52,13 @@ typedef enum {
 
 static inline const char* get_name_for_CounterID(CounterID id) {
     static const char* names[] = {
-        "PlayerHealth",
-        "PlayerStamina",
+        "ActiveAudioChannels",
         "DrawCalls",
         "ShaderBinds",
         "TextureBinds",
         "MainRenderContext",
-        "ActiveAudioChannels",
+        "PlayerHealth",
+        "PlayerStamina",
     };
     if (id <= 6) return names[id];
     return "(invalid)";
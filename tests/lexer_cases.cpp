@@ -0,0 +1,47 @@
+// Fixture for tests/lexer_test.sh. Identifiers named Live* must be found,
+// anything named Dead* must not.
+
+// REGISTER_COUNTER(DeadLineComment)
+/* REGISTER_COUNTER(DeadBlockComment)
+   REGISTER_UNIQUE_COUNTER(DeadBlockComment2) */
+const char* s = "REGISTER_COUNTER(DeadString) /* not a comment";
+const char* r = R"x(REGISTER_COUNTER(DeadRaw) )" )x";
+const char* u = u8R"(REGISTER_COUNTER(DeadRawPrefixed))";
+char q = '"'; int n = 1'000; double e = 1e+5;
+
+auto a = REGISTER_COUNTER(LiveFirst); auto b = REGISTER_COUNTER(LiveSameLine, 40);
+auto c = REGISTER_UNIQUE_COUNTER(
+    LiveMultiLine,
+    /* value */ 50
+);
+
+#if 0
+const char* glob = "src/*.cpp";
+auto d = REGISTER_COUNTER(DeadIf0); // don't count this
+#if 1
+auto f = REGISTER_COUNTER(DeadNestedIf1);
+#endif
+#else
+auto g = REGISTER_COUNTER(LiveElseOfIf0);
+#endif
+
+#if 1
+auto h = REGISTER_COUNTER(LiveIf1);
+#else
+auto i = REGISTER_COUNTER(DeadElseOfIf1);
+#endif
+
+#ifdef SOME_FLAG
+auto j = REGISTER_COUNTER(LiveIfdef);
+#endif
+
+#ifdef REGISTER_COUNTER
+(void)0;
+#endif
+#pragma REGISTER_COUNTER
+(void)0;
+
+#define REGISTER_COUNTER(name, ...) CounterID::name
+#define USE_IT() Profiler::Increment(REGISTER_COUNTER(LiveMacroBody))
+auto k = MY_REGISTER_COUNTER(DeadPrefixed); auto l = REGISTER_COUNTER  (LiveSpaced);
+auto m = REGISTER_COUNTER(LiveLast);
@@ -0,0 +1,48 @@
+#!/bin/bash
+# Runs metacounter over tests/lexer_cases.cpp and checks the generated enum
+# against the identifiers the marker lexer is expected to find.
+#
+# Usage: tests/lexer_test.sh
+# Environment: METACOUNTER (default: builds bin/metacounter)
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+if [ -z "$METACOUNTER" ]; then
+    (cd "$ROOT" && bash build.sh > /dev/null)
+    METACOUNTER=$ROOT/bin/metacounter
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+cat > "$WORK/config.txt" <<CFG
+output_file: $WORK/registry.h
+scan_ext: .cpp
+begin_sources
+$ROOT/tests/lexer_cases.cpp
+end_sources
+CFG
+
+cat > "$WORK/expected.txt" <<EXPECTED
+LiveFirst = 0
+LiveSameLine = 40
+LiveMultiLine = 50
+LiveElseOfIf0 = 51
+LiveIf1 = 52
+LiveIfdef = 53
+LiveMacroBody = 54
+LiveSpaced = 55
+LiveLast = 56
+MAX_COUNT = 57
+EXPECTED
+
+"$METACOUNTER" "$WORK/config.txt" > /dev/null
+sed -n '/^enum class/,/^};/p' "$WORK/registry.h" | sed -e '1d' -e '$d' -e 's/^ *//' -e 's/,$//' > "$WORK/actual.txt"
+
+if diff -u "$WORK/expected.txt" "$WORK/actual.txt"; then
+    echo "lexer_test: PASS"
+else
+    echo "lexer_test: FAIL"
+    exit 1
+fi
@@ -0,0 +1,113 @@
+#!/bin/bash
+# Runs metacounter as N separate '--shard i/N' processes plus 'merge' and
+# checks that the header, warnings and errors are identical to a single run.
+#
+# Usage: tests/shard_test.sh
+# Environment: METACOUNTER (default: builds bin/metacounter)
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+if [ -z "$METACOUNTER" ]; then
+    (cd "$ROOT" && bash build.sh > /dev/null)
+    METACOUNTER=$ROOT/bin/metacounter
+fi
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+# --- Fixture: shared duplicates, explicit values, a compilation database ---
+for d in engine game tools; do
+    mkdir -p src/$d
+    for ((i = 0; i < 25; ++i)); do
+        {
+            echo "#include \"../common.h\""
+            echo "auto a$i = REGISTER_COUNTER(${d}_$i);"
+            echo "auto b$i = REGISTER_COUNTER(Shared_$((i % 6)));"
+            if ((i % 8 == 0)); then
+                echo "auto c$i = REGISTER_COUNTER(${d}_Explicit_$i, $((1000 + i * 10)));"
+            fi
+        } > src/$d/file_$i.cpp
+    done
+done
+echo "auto common = REGISTER_COUNTER(FromCommonHeader);" > src/common.h
+
+mkdir -p build
+{
+    echo "["
+    for ((i = 0; i < 25; ++i)); do
+        [ $i -gt 0 ] && echo ","
+        echo "{\"directory\": \"$WORK/build\", \"file\": \"$WORK/src/game/file_$i.cpp\", \"arguments\": [\"g++\", \"-I../src\", \"-c\", \"../src/game/file_$i.cpp\"]}"
+    done
+    echo "]"
+} > build/compile_commands.json
+
+write_config() {
+    cat > "$1" <<CFG
+output_file: registry.h
+scan_ext: .h .cpp
+duplicate_policy: warn
+compdb_headers: yes
+begin_sources
+$2
+end_sources
+CFG
+}
+
+failures=0
+
+# Compares a single run against N shards + merge for one config.
+check() {
+    local name=$1 config=$2 shards=$3
+    local single_rc=0 merge_rc=0
+
+    rm -f registry.h *.partial
+    "$METACOUNTER" "$config" > single.out 2> single.err || single_rc=$?
+    [ -f registry.h ] && mv registry.h single.h || rm -f single.h
+
+    for ((s = 0; s < shards; ++s)); do
+        "$METACOUNTER" "$config" --shard $s/$shards --partial shard_$s.partial > /dev/null &
+    done
+    wait
+    "$METACOUNTER" merge "$config" shard_*.partial > merge.out 2> merge.err || merge_rc=$?
+
+    local ok=1
+    [ $single_rc -eq $merge_rc ] || ok=0
+    if [ -f single.h ]; then cmp -s single.h registry.h || ok=0; else [ ! -f registry.h ] || ok=0; fi
+    diff -q <(grep -v '^Metacounter:' single.out) <(grep -v '^Metacounter:' merge.out) > /dev/null || ok=0
+    cmp -s single.err merge.err || ok=0
+
+    if [ $ok -eq 1 ]; then
+        echo "shard_test: $name ($shards shards): PASS"
+    else
+        echo "shard_test: $name ($shards shards): FAIL (rc $single_rc vs $merge_rc)"
+        failures=$((failures + 1))
+    fi
+}
+
+write_config walk.txt "src/"
+write_config compdb.txt "build/compile_commands.json
+src/tools/"
+
+for shards in 1 2 3 7; do
+    check "directory walk" walk.txt $shards
+    check "compile_commands" compdb.txt $shards
+done
+
+# A unique marker redefined elsewhere must fail the same way in both modes.
+echo "auto u = REGISTER_UNIQUE_COUNTER(MainContext);" > src/engine/unique_a.cpp
+echo "auto v = REGISTER_COUNTER(MainContext);" > src/tools/unique_b.cpp
+for shards in 2 5; do
+    check "unique conflict" walk.txt $shards
+done
+grep -q "Unique identifier 'MainContext' redefined" merge.err || {
+    echo "shard_test: unique conflict was not reported"
+    failures=$((failures + 1))
+}
+
+if [ $failures -ne 0 ]; then
+    echo "shard_test: FAIL"
+    exit 1
+fi
+echo "shard_test: PASS"